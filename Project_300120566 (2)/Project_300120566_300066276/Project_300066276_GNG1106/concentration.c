@@ -13,6 +13,11 @@ December 8 2019
 #include <math.h>
 #include <float.h>
 #include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>    // compiled with -fopenmp, Parareal slices run on all cores
+#endif
 
 // Some definitions
 #define NUM_POINTS 100   // Number of points used for plotting
@@ -21,6 +26,26 @@ December 8 2019
 #define MAXRECORDS 5      //The max number of input records we will save in a file
 #define TRUE 1
 #define FALSE 0
+#define TRAJFILE "trajectories.bin"
+#define TRAJINDEX "trajectories.idx"  //position of every block in TRAJFILE, one long each
+#define TRAJ_MAGIC 0x324A5254u //"TRJ2", marks the start of every trajectory block
+#define NUM_SERIES 4          //time_axis, cr1, cr2, cr3
+#define CODEC_UNIFORM 0       //time axis rebuilt from its start and increment
+#define CODEC_XOR 1           //see encodeSeriesXor
+#define CODEC_DOD 2           //see encodeSeriesDod
+//Worst case encoding (XOR): 64 bits for the first value, then 2 control bits,
+//5 leading zero bits, 6 length bits and 64 meaningful bits per value
+#define MAX_SERIES_BYTES ((64+(NUM_POINTS-1)*77)/8+1)
+#define NUM_REACTORS 3
+#define NUM_FEEDS 2           //feed C01 into reactor 1 and feed C03 into reactor 3
+#define FEED_C01 0
+#define FEED_C03 1
+#define MAX_FEED_SIGNALS 500  //The max number of feed signals read from a file
+#define FEEDOUTFILE "feed_results.txt"
+#define PI 3.14159265358979323846
+#define PARAREAL_COARSE_STEPS 4  //implicit steps the coarse guess takes across one slice
+#define PARAREAL_TOL 1e-10    //relative change in the slice start values that counts as converged
+
 
 typedef struct reactor_tag
 {
@@ -63,13 +88,124 @@ typedef struct user_input_tag
     double time_final;
 } USER_INPUTS;
 
+//Options given on the command line, all of them are off by default
+typedef struct options_tag
+{
+    int archive;        //TRUE to append the computed concentrations to TRAJFILE
+    int load_record;    //archived trajectory to plot (1 is the first), 0 for none
+    char *feeds_file;   //file of feed signals to evaluate, NULL for none
+    int parareal_steps; //steps per plotted point for Parareal, 0 for the serial calculation
+    int parareal_slices; //time slices for Parareal, 0 for one per OpenMP thread
+    int benchmark;      //TRUE to also time direct stepping against Parareal or -feeds
+} OPTIONS;
+
+//Buffer used to pack a compressed series one bit at a time
+typedef struct bit_stream_tag
+{
+    unsigned char bytes[MAX_SERIES_BYTES];
+    int num_bits;
+} BIT_STREAM;
+
+//Written in front of every compressed trajectory so each block can be
+//decoded on its own. The inputs identify the scenario; the curves are
+//kept as well because Parareal results only agree with the serial ones
+//to PARAREAL_TOL, and reading them back is cheaper than a long run.
+typedef struct trajectory_header_tag
+{
+    unsigned int magic;
+    int num_points;
+    USER_INPUTS inputs;               //all 15 inputs of the scenario
+    int steps_per_point;              //time steps taken between two plotted points
+    int parareal;                     //TRUE when computed with Parareal
+    int series_codec[NUM_SERIES];     //CODEC_ used for time_axis, cr1, cr2, cr3
+    int series_bytes[NUM_SERIES];     //compressed size of time_axis, cr1, cr2, cr3
+    double time_start;
+    double time_inc;
+} TRAJECTORY_HEADER;
+
+//Feed concentrations that can change over time, value ix is applied
+//during the time step from time ix*inc to (ix+1)*inc. Any length.
+typedef struct feed_signal_tag
+{
+    int num_points;
+    double *c_01;
+    double *c_03;
+} FEED_SIGNAL;
+
+//Concentrations computed for a feed signal, same length as the signal
+typedef struct signal_response_tag
+{
+    int num_points;
+    double *time_axis;
+    double *cr1;
+    double *cr2;
+    double *cr3;
+} SIGNAL_RESPONSE;
+
+//Response of the three reactors computed once for a fixed configuration,
+//used to get the response to any feed signal by convolution.
+//The responses cover num_points time steps of tf/(NUM_POINTS-1).
+typedef struct impulse_response_tag
+{
+    int num_points;                                 //longest feed signal that can be convolved
+    int fft_size;                                   //power of two, at least 2*num_points-1
+    double inc;                                     //time step, tf/(NUM_POINTS-1)
+    double time_axis[NUM_POINTS];                   //time of the first NUM_POINTS values, for E(t)
+    double *h[NUM_FEEDS][NUM_REACTORS];             //response to a unit feed held for the first time step
+    double *h_re[NUM_FEEDS][NUM_REACTORS];          //spectrum of h, real part
+    double *h_im[NUM_FEEDS][NUM_REACTORS];          //spectrum of h, imaginary part
+    double *initial[NUM_REACTORS];                  //response to C10, C20, C30 with no feed
+} IMPULSE_RESPONSE;
+
+//What the parallel-in-time calculation reports back
+typedef struct parareal_stats_tag
+{
+    int slices;              //number of time slices
+    int iterations;          //number of parallel sweeps through the slices
+    double ideal_speedup;    //steps done one after the other, serial over parallel
+} PARAREAL_STATS;
+
 // function prototypes
-void receiveUserInputs(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr);
+void receiveUserInputs(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr, int ask_feeds);
 int testConstraints(FLOW_RATES *fPtr);
 void calculateConcentrations(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c);
+void stepConcentrations(REACTORS *r, FLOW_RATES *f, double c01, double c03,
+                        double prev[], double next[], double inc);
+int calculateImpulseResponse(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c,
+                             int num_points, IMPULSE_RESPONSE *ir);
+int convolveFeedSignal(IMPULSE_RESPONSE *ir, FEED_SIGNAL *s, SIGNAL_RESPONSE *out);
+void calculateResidenceTime(IMPULSE_RESPONSE *ir, int feed, double e[]);
+void evaluateFeedSignals(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, char *filename, int benchmark);
+int calculateFeedSignal(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, double inc,
+                        FEED_SIGNAL *s, SIGNAL_RESPONSE *out);
+int readFeedSignals(char *filename, FEED_SIGNAL signals[], int max);
+void freeImpulseResponse(IMPULSE_RESPONSE *ir);
+void freeFeedSignal(FEED_SIGNAL *s);
+void freeSignalResponse(SIGNAL_RESPONSE *out);
+void fft(double re[], double im[], int n, int inverse);
+void calculateConcentrationsFine(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, int substeps);
+void stepSlice(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, long first, long last,
+               int substeps, double inc, double prev[]);
+int calculateConcentrationsParareal(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c,
+                                    int substeps, int slices, PARAREAL_STATS *stats);
+void coarseStep(REACTORS *r, FLOW_RATES *f, double c01, double c03,
+                double prev[], double next[], double dt);
+void coarseSlice(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, int steps, double dt,
+                 double prev[], double next[]);
+double getWallTime(void);
 void plotTable(CONCENTRATIONS *cPtr);
 void storeFiles(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr);
 int retrieveFiles(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr);
+void storeTrajectory(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr,
+                     int steps_per_point, int parareal);
+int retrieveTrajectory(int record, REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr);
+int readOptions(int argc, char *argv[], OPTIONS *oPtr);
+void encodeSeriesXor(double [], int, BIT_STREAM *);
+int decodeSeriesXor(BIT_STREAM *, int, double [], int);
+void encodeSeriesDod(double [], int, BIT_STREAM *);
+int decodeSeriesDod(BIT_STREAM *, int, double [], int);
+void putBits(BIT_STREAM *, unsigned long long, int);
+unsigned long long getBits(BIT_STREAM *, int *, int);
 double getMinDouble(double [], int);
 double getMaxDouble(double [], int);
 
@@ -81,27 +217,100 @@ Description: This function computes a set of points for plotting.
          inputs so the values comply with the equations, If the values are valid,
          they will be plotted on the output graph. The inputs can be saved to a file
          for future use. It will save up to 5 records.
+         Command line options (see readOptions) can archive the computed
+         concentrations, plot an archived trajectory without any input,
+         evaluate a file of feed signals against the entered reactors, or
+         use parallel-in-time integration with more steps per plotted point.
 ------------------------------------------------------------------------*/
-int main(void)
+int main(int argc, char *argv[])
 {
     REACTORS reactors;
     CONCENTRATIONS concentrations;
     FLOW_RATES flow_rates;
+    CONCENTRATIONS serial;
+    PARAREAL_STATS stats;
+    OPTIONS options;
+    double time_start, parallel_time, serial_time;
+
+    if(!readOptions(argc, argv, &options))
+        return(1);
+
+    if(options.load_record>0)
+    {
+        if(!retrieveTrajectory(options.load_record-1, &reactors, &flow_rates,&concentrations))
+        {
+            printf("Sorry, archived trajectory %d could not be read from %s\n",
+                   options.load_record, TRAJFILE);
+            return(1);
+        }
+        printf("Archived trajectory %d\n", options.load_record);
+        printf("Volumes V1: %lf V2: %lf  V3: %lf\n", reactors.v_1, reactors.v_2, reactors.v_3);
+        printf("Q Values  Q01: %lf Q03: %lf  Q12: %lf  Q23: %lf  Q31: %lf  Q33: %lf\n",
+               flow_rates.Q_01, flow_rates.Q_03, flow_rates.Q_12, flow_rates.Q_23, flow_rates.Q_31, flow_rates.Q_33);
+        printf("Concentrations C01: %lf C03: %lf  C10: %lf  C20: %lf C30: %lf\n",
+               concentrations.c_01, concentrations.c_03, concentrations.c1_0, concentrations.c2_0, concentrations.c3_0);
+        printf("Time Final tf: %lf\n", concentrations.time_final);
+        plotTable(&concentrations);
+        return(0);
+    }
 
     if(!retrieveFiles(&reactors, &flow_rates,&concentrations))
     {
         //if there was no saved input chosen, aske the user for input
         do
         {
-            receiveUserInputs(&reactors, &flow_rates,&concentrations);
+            receiveUserInputs(&reactors, &flow_rates,&concentrations, options.feeds_file==NULL);
         }
         while(testConstraints(&flow_rates)==FALSE);
 
-        storeFiles(&reactors, &flow_rates,&concentrations);
+        //C01 and C03 are not entered with -feeds, so there is nothing to save
+        if(options.feeds_file==NULL)
+            storeFiles(&reactors, &flow_rates,&concentrations);
 
     }
+    else if(options.feeds_file!=NULL)
+        printf("C01 and C03 of the record are not used, the feed signals replace them\n");
 
-    calculateConcentrations(&reactors, &flow_rates,&concentrations);
+    if(options.feeds_file!=NULL)
+    {
+        evaluateFeedSignals(&reactors, &flow_rates,&concentrations, options.feeds_file, options.benchmark);
+        return(0);
+    }
+
+    if(options.parareal_steps>0)
+    {
+        time_start = getWallTime();
+        if(!calculateConcentrationsParareal(&reactors, &flow_rates,&concentrations,
+                                            options.parareal_steps, options.parareal_slices, &stats))
+        {
+            printf("Using the serial calculation instead\n");
+            calculateConcentrationsFine(&reactors, &flow_rates,&concentrations, options.parareal_steps);
+            if(!isfinite(concentrations.cr1[NUM_POINTS-1]) || !isfinite(concentrations.cr2[NUM_POINTS-1]) ||
+               !isfinite(concentrations.cr3[NUM_POINTS-1]))
+                printf("The serial calculation does not stay finite either, try more steps per point\n");
+        }
+        else
+        {
+            parallel_time = getWallTime()-time_start;
+            printf("Parareal used %d slices and took %d iterations, ideal speedup %lf\n",
+                   stats.slices, stats.iterations, stats.ideal_speedup);
+        }
+        if(options.benchmark && (stats.iterations>0))
+        {
+            serial = concentrations;
+            time_start = getWallTime();
+            calculateConcentrationsFine(&reactors, &flow_rates,&serial, options.parareal_steps);
+            serial_time = getWallTime()-time_start;
+            printf("Serial time: %lf s  Parallel time: %lf s  Speedup: %lf\n", serial_time, parallel_time,
+                   (parallel_time>0) ? serial_time/parallel_time : 0);
+        }
+    }
+    else
+        calculateConcentrations(&reactors, &flow_rates,&concentrations);
+
+    if(options.archive)
+        storeTrajectory(&reactors, &flow_rates,&concentrations,
+                        (options.parareal_steps>0) ? options.parareal_steps : 1, options.parareal_steps>0);
 
     plotTable(&concentrations);
 
@@ -111,21 +320,31 @@ int main(void)
 Function: receiveUserInputs
 Parameters:
     REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr
+    ask_feeds: FALSE when C01 and C03 come from feed signals instead
 Return:  void
 Description:  requests the user inputs, initial contraints will be applied to ensure
             the project requested input constraints were verified.
             The values will be stored in the structures defined and declared in the
             calling function.
 ------------------------------------------------------------------------*/
-void receiveUserInputs(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr)
+void receiveUserInputs(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr, int ask_feeds)
 {
     int pass=TRUE;
 
 
-    printf("Enter C01:\n");
-    scanf("%lf",&cPtr->c_01);
-    printf("Enter C03:\n");
-    scanf("%lf",&cPtr->c_03);
+    if(ask_feeds)
+    {
+        printf("Enter C01:\n");
+        scanf("%lf",&cPtr->c_01);
+        printf("Enter C03:\n");
+        scanf("%lf",&cPtr->c_03);
+    }
+    else
+    {
+        printf("C01 and C03 are taken from the feed signals\n");
+        cPtr->c_01 = 0;
+        cPtr->c_03 = 0;
+    }
     printf("Enter C10:\n");
     scanf("%lf",&cPtr->c1_0);
     printf("Enter C20:\n");
@@ -218,8 +437,24 @@ Description:  Based on the number of points and the time for the reaction,
             relies on the other concentrations.
 ------------------------------------------------------------------------*/
 void calculateConcentrations(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c)
+{
+    calculateConcentrationsFine(r, f, c, 1);
+}
+
+/*-----------------------------------------------------------------------
+Function: calculateConcentrationsFine
+Parameters:
+    REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c
+    substeps: number of time steps taken between two plotted points
+Return:  void
+Description:  Same as calculateConcentrations, but takes substeps smaller
+            steps between the plotted points so long final times stay
+            accurate. With substeps equal to 1 it is calculateConcentrations.
+------------------------------------------------------------------------*/
+void calculateConcentrationsFine(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, int substeps)
 {
     double inc;
+    double prev[NUM_REACTORS];
     int ix;
 
     c->time_axis[0]=0;
@@ -228,11 +463,940 @@ void calculateConcentrations(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c)
     c->cr3[0]=c->c3_0;
     inc = (c->time_final)/(NUM_POINTS-1);
     for(ix=1; ix<NUM_POINTS; ix++)
+        c->time_axis[ix]=c->time_axis[ix-1]+inc;
+
+    prev[0]=c->cr1[0];
+    prev[1]=c->cr2[0];
+    prev[2]=c->cr3[0];
+    stepSlice(r, f, c, 0, (long)(NUM_POINTS-1)*substeps, substeps, inc, prev);
+}
+
+/*-----------------------------------------------------------------------
+Function: stepSlice
+Parameters:
+    REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c
+    first, last: time steps the slice starts and ends at, counted from 0
+    substeps: number of time steps taken between two plotted points
+    inc: time between two plotted points
+    prev: concentrations after step first, replaced by the ones after step last
+Return:  void
+Description:  Takes the time steps from first to last, storing the
+            concentrations in the arrays whenever a step lands on a
+            plotted point.
+------------------------------------------------------------------------*/
+void stepSlice(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, long first, long last,
+               int substeps, double inc, double prev[])
+{
+    double next[NUM_REACTORS];
+    long k;
+    int ix;
+
+    for(k=first+1; k<=last; k++)
     {
-        c->cr1[ix]= (c->cr1[ix-1]+(((f->Q_01*c->c_01)+(f->Q_31*c->cr3[ix-1])-(f->Q_12*c->cr1[ix-1]))/r->v_1)*inc);
-        c->cr2[ix]=(c->cr2[ix-1]+(((f->Q_12*c->cr1[ix])-(f->Q_23*c->cr2[ix-1]))/r->v_2)*inc);
-        c->cr3[ix]=(c->cr3[ix-1]+(((f->Q_03*c->c_03)+(f->Q_23*c->cr2[ix-1])-(f->Q_31*c->cr3[ix-1])+(f->Q_33*c->cr3[ix-1]))/r->v_3)*inc);
+        stepConcentrations(r, f, c->c_01, c->c_03, prev, next, inc/substeps);
+        memcpy(prev, next, sizeof(next));
+        if(k%substeps==0)
+        {
+            ix = (int)(k/substeps);
+            c->cr1[ix]=prev[0];
+            c->cr2[ix]=prev[1];
+            c->cr3[ix]=prev[2];
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: stepConcentrations
+Parameters:
+    REACTORS *r, FLOW_RATES *f
+    c01, c03: feed concentrations during this step
+    prev: concentrations of reactors 1 to 3 at the start of the step
+    next: receives the concentrations at the end of the step
+    inc: length of the step (delta t)
+Return:  void
+Description:  Advances the three reactors by one time step. Reactor 2 uses
+            the new value of reactor 1, as in the original calculation.
+------------------------------------------------------------------------*/
+void stepConcentrations(REACTORS *r, FLOW_RATES *f, double c01, double c03,
+                        double prev[], double next[], double inc)
+{
+    next[0]=(prev[0]+(((f->Q_01*c01)+(f->Q_31*prev[2])-(f->Q_12*prev[0]))/r->v_1)*inc);
+    next[1]=(prev[1]+(((f->Q_12*next[0])-(f->Q_23*prev[1]))/r->v_2)*inc);
+    next[2]=(prev[2]+(((f->Q_03*c03)+(f->Q_23*prev[1])-(f->Q_31*prev[2])+(f->Q_33*prev[2]))/r->v_3)*inc);
+}
+
+/*-----------------------------------------------------------------------
+Function: calculateConcentrationsParareal
+Parameters:
+    REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c
+    substeps: number of time steps taken between two plotted points
+    slices: number of time slices, 0 for one per OpenMP thread
+    PARAREAL_STATS *stats: receives the slices, iterations and the ideal speedup
+Return:  TRUE if successful, FALSE if the slice start values stopped being
+         finite numbers or there was not enough memory
+Description:  Does the work of calculateConcentrationsFine but splits the
+            time steps into slices that are stepped through at the same
+            time (Parareal). PARAREAL_COARSE_STEPS implicit steps across
+            each slice guess its start, the slices are stepped through in
+            parallel from those guesses, and the guesses are corrected:
+                U[s+1] = fine(U[s]) + coarse(new U[s]) - coarse(U[s])
+            Once the guesses change by less than PARAREAL_TOL the last
+            sweep started within PARAREAL_TOL of them, so the result agrees
+            with the serial one to about PARAREAL_TOL. If the guesses stop
+            changing at all, or after one sweep per slice, every slice
+            started from its serial value and the result is the serial one.
+------------------------------------------------------------------------*/
+int calculateConcentrationsParareal(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c,
+                                    int substeps, int slices, PARAREAL_STATS *stats)
+{
+    double (*start)[NUM_REACTORS];   //U, start value of every slice
+    double (*fine)[NUM_REACTORS];    //fine value at the end of every slice
+    double (*coarse)[NUM_REACTORS];  //coarse value at the end of every slice
+    long *bound;                     //time step where every slice starts
+    double prev[NUM_REACTORS], next[NUM_REACTORS], guess[NUM_REACTORS];
+    double inc, change, size;
+    long total, longest, coarse_steps;
+    int pass=TRUE;
+    int iter, sx, rx, ix;
+
+    stats->slices = 0;
+    stats->iterations = 0;
+    stats->ideal_speedup = 0;
+
+    inc = (c->time_final)/(NUM_POINTS-1);
+    c->time_axis[0]=0;
+    c->cr1[0]=c->c1_0;
+    c->cr2[0]=c->c2_0;
+    c->cr3[0]=c->c3_0;
+    for(ix=1; ix<NUM_POINTS; ix++)
         c->time_axis[ix]=c->time_axis[ix-1]+inc;
+
+    //one slice per thread, but never more slices than time steps
+    total = (long)(NUM_POINTS-1)*substeps;
+    if(slices<=0)
+    {
+#ifdef _OPENMP
+        slices = omp_get_max_threads();
+#else
+        slices = 1;
+#endif
+    }
+    if(slices>total)
+        slices = (int)total;
+
+    start = malloc((slices+1)*sizeof(*start));
+    fine = malloc(slices*sizeof(*fine));
+    coarse = malloc(slices*sizeof(*coarse));
+    bound = malloc((slices+1)*sizeof(long));
+    if((start==NULL) || (fine==NULL) || (coarse==NULL) || (bound==NULL))
+    {
+        printf("Sorry, there is not enough memory for %d Parareal slices\n", slices);
+        free(start);
+        free(fine);
+        free(coarse);
+        free(bound);
+        return(FALSE);
+    }
+
+    longest = 0;
+    for(sx=0; sx<=slices; sx++)
+    {
+        bound[sx] = total*sx/slices;
+        if((sx>0) && (bound[sx]-bound[sx-1]>longest))
+            longest = bound[sx]-bound[sx-1];
+    }
+
+    //first guess for the start of every slice, coarse steps only
+    start[0][0]=c->c1_0;
+    start[0][1]=c->c2_0;
+    start[0][2]=c->c3_0;
+    for(sx=0; sx<slices; sx++)
+    {
+        coarseSlice(r, f, c, PARAREAL_COARSE_STEPS,
+                    (bound[sx+1]-bound[sx])*(inc/substeps)/PARAREAL_COARSE_STEPS, start[sx], coarse[sx]);
+        memcpy(start[sx+1], coarse[sx], sizeof(start[sx+1]));
+    }
+    coarse_steps = (long)slices*PARAREAL_COARSE_STEPS;
+
+    for(iter=1; ; iter++)
+    {
+        //fine steps through every slice at the same time
+#ifdef _OPENMP
+        #pragma omp parallel for private(prev)
+#endif
+        for(sx=0; sx<slices; sx++)
+        {
+            memcpy(prev, start[sx], sizeof(prev));
+            stepSlice(r, f, c, bound[sx], bound[sx+1], substeps, inc, prev);
+            memcpy(fine[sx], prev, sizeof(fine[sx]));
+        }
+
+        //the last sweep started every slice from its serial value
+        if(iter==slices)
+            break;
+
+        //correct the slice start values one after the other, coarse steps only.
+        //When a start did not change, guess-coarse is exactly 0 and the
+        //corrected value is exactly the fine one.
+        change = 0;
+        size = 0;
+        for(sx=0; (sx<slices) && pass; sx++)
+        {
+            coarseSlice(r, f, c, PARAREAL_COARSE_STEPS,
+                        (bound[sx+1]-bound[sx])*(inc/substeps)/PARAREAL_COARSE_STEPS, start[sx], guess);
+            for(rx=0; rx<NUM_REACTORS; rx++)
+            {
+                next[rx] = fine[sx][rx]+(guess[rx]-coarse[sx][rx]);
+                //a NaN would compare as no change at all
+                if(!isfinite(next[rx]))
+                    pass = FALSE;
+                if(fabs(next[rx]-start[sx+1][rx])>change)
+                    change = fabs(next[rx]-start[sx+1][rx]);
+                if(fabs(next[rx])>size)
+                    size = fabs(next[rx]);
+            }
+            memcpy(coarse[sx], guess, sizeof(coarse[sx]));
+            memcpy(start[sx+1], next, sizeof(start[sx+1]));
+        }
+        coarse_steps = coarse_steps+(long)slices*PARAREAL_COARSE_STEPS;
+
+        if(!pass)
+        {
+            printf("Sorry, Parareal diverged, slice %d of %d did not start from a finite value after %d iterations\n",
+                   sx, slices, iter);
+            break;
+        }
+        //the sweep just done already started from (about) these values
+        if(change<=PARAREAL_TOL*(1+size))
+            break;
+    }
+
+    if(pass)
+    {
+        stats->slices = slices;
+        stats->iterations = iter;
+        //one coarse step is counted as costing the same as one fine step
+        stats->ideal_speedup = (double)total/((double)iter*longest+coarse_steps);
+    }
+    free(start);
+    free(fine);
+    free(coarse);
+    free(bound);
+    return(pass);
+}
+
+/*-----------------------------------------------------------------------
+Function: coarseSlice
+Parameters:
+    REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c
+    steps: number of coarse steps across the slice
+    dt: length of one coarse step
+    prev: concentrations at the start of the slice
+    next: receives the concentrations at the end of the slice
+Return:  void
+Description:  Crosses a Parareal slice with a few long coarse steps.
+------------------------------------------------------------------------*/
+void coarseSlice(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, int steps, double dt,
+                 double prev[], double next[])
+{
+    double temp[NUM_REACTORS];
+    int k;
+
+    memcpy(next, prev, sizeof(temp));
+    for(k=0; k<steps; k++)
+    {
+        coarseStep(r, f, c->c_01, c->c_03, next, temp, dt);
+        memcpy(next, temp, sizeof(temp));
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: coarseStep
+Parameters:
+    REACTORS *r, FLOW_RATES *f
+    c01, c03: feed concentrations during this step
+    prev: concentrations of reactors 1 to 3 at the start of the step
+    next: receives the concentrations at the end of the step
+    dt: length of the step
+Return:  void
+Description:  One implicit trapezoidal (Crank-Nicolson) step, which stays
+            stable and accurate for steps much longer than the fine ones.
+            Solves (I - dt/2*A) next = (I + dt/2*A) prev + dt*b with
+            Cramer's rule, where A and b come from the reactor equations.
+------------------------------------------------------------------------*/
+void coarseStep(REACTORS *r, FLOW_RATES *f, double c01, double c03,
+                double prev[], double next[], double dt)
+{
+    double a[NUM_REACTORS][NUM_REACTORS];
+    double m[NUM_REACTORS][NUM_REACTORS];
+    double rhs[NUM_REACTORS];
+    double det;
+    int i, j;
+
+    a[0][0]=-f->Q_12/r->v_1;
+    a[0][1]=0;
+    a[0][2]=f->Q_31/r->v_1;
+    a[1][0]=f->Q_12/r->v_2;
+    a[1][1]=-f->Q_23/r->v_2;
+    a[1][2]=0;
+    a[2][0]=0;
+    a[2][1]=f->Q_23/r->v_3;
+    a[2][2]=(f->Q_33-f->Q_31)/r->v_3;
+
+    rhs[0]=prev[0]+dt*f->Q_01*c01/r->v_1;
+    rhs[1]=prev[1];
+    rhs[2]=prev[2]+dt*f->Q_03*c03/r->v_3;
+    for(i=0; i<NUM_REACTORS; i++)
+    {
+        for(j=0; j<NUM_REACTORS; j++)
+        {
+            m[i][j]=((i==j) ? 1 : 0)-dt/2*a[i][j];
+            rhs[i]+=dt/2*a[i][j]*prev[j];
+        }
+    }
+
+    det = m[0][0]*(m[1][1]*m[2][2]-m[1][2]*m[2][1])
+         -m[0][1]*(m[1][0]*m[2][2]-m[1][2]*m[2][0])
+         +m[0][2]*(m[1][0]*m[2][1]-m[1][1]*m[2][0]);
+    if(det==0)
+    {
+        //cannot be solved, fall back to an ordinary step
+        stepConcentrations(r, f, c01, c03, prev, next, dt);
+        return;
+    }
+
+    next[0]=(rhs[0]*(m[1][1]*m[2][2]-m[1][2]*m[2][1])
+            -m[0][1]*(rhs[1]*m[2][2]-m[1][2]*rhs[2])
+            +m[0][2]*(rhs[1]*m[2][1]-m[1][1]*rhs[2]))/det;
+    next[1]=(m[0][0]*(rhs[1]*m[2][2]-m[1][2]*rhs[2])
+            -rhs[0]*(m[1][0]*m[2][2]-m[1][2]*m[2][0])
+            +m[0][2]*(m[1][0]*rhs[2]-rhs[1]*m[2][0]))/det;
+    next[2]=(m[0][0]*(m[1][1]*rhs[2]-rhs[1]*m[2][1])
+            -m[0][1]*(m[1][0]*rhs[2]-rhs[1]*m[2][0])
+            +rhs[0]*(m[1][0]*m[2][1]-m[1][1]*m[2][0]))/det;
+}
+
+/*-------------------------------------------------
+ Function: getWallTime
+ Parameters: none
+ Return value: the current time in seconds
+ Description: Uses the OpenMP wall clock when it is
+              available, otherwise the processor clock.
+-------------------------------------------------*/
+double getWallTime(void)
+{
+#ifdef _OPENMP
+    return(omp_get_wtime());
+#else
+    return((double)clock()/CLOCKS_PER_SEC);
+#endif
+}
+
+/*-----------------------------------------------------------------------
+Function: evaluateFeedSignals
+Parameters:
+    REACTORS *r, FLOW_RATES *f
+    CONCENTRATIONS *c: supplies C10, C20, C30 and the final time tf
+    filename: file of feed signals, see readFeedSignals
+    benchmark: TRUE to also time direct stepping of every signal
+Return:  void
+Description:  Computes the impulse response of the reactors once, then the
+            concentrations for every feed signal in the file by convolution.
+            The concentrations are written to FEEDOUTFILE and the residence
+            time distributions E(t) of both feeds are printed.
+------------------------------------------------------------------------*/
+void evaluateFeedSignals(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, char *filename, int benchmark)
+{
+    static FEED_SIGNAL signals[MAX_FEED_SIGNALS];
+    static IMPULSE_RESPONSE ir;
+    SIGNAL_RESPONSE out, direct;
+    double e01[NUM_POINTS], e03[NUM_POINTS];
+    double time_start, response_time, convolve_time, step_time, diff, size, worst;
+    FILE* fp;
+    int num_signals, longest=1;
+    int i, ix;
+
+    num_signals = readFeedSignals(filename, signals, MAX_FEED_SIGNALS);
+    if(num_signals<=0)
+    {
+        printf("Sorry, no feed signals could be read from %s\n", filename);
+        return;
+    }
+    for(i=0; i<num_signals; i++)
+    {
+        if(signals[i].num_points>longest)
+            longest = signals[i].num_points;
+    }
+
+    time_start = getWallTime();
+    if(!calculateImpulseResponse(r, f, c, longest, &ir))
+    {
+        printf("Sorry, not enough memory for %d points\n", longest);
+        for(i=0; i<num_signals; i++)
+            freeFeedSignal(&signals[i]);
+        return;
+    }
+    response_time = getWallTime()-time_start;
+
+    if(benchmark)
+    {
+        //time both ways on their own, without the printing and the file
+        time_start = getWallTime();
+        for(i=0; i<num_signals; i++)
+        {
+            if(convolveFeedSignal(&ir, &signals[i], &out))
+                freeSignalResponse(&out);
+        }
+        convolve_time = getWallTime()-time_start;
+
+        time_start = getWallTime();
+        for(i=0; i<num_signals; i++)
+        {
+            if(calculateFeedSignal(r, f, c, ir.inc, &signals[i], &direct))
+                freeSignalResponse(&direct);
+        }
+        step_time = getWallTime()-time_start;
+
+        //largest difference between the two, relative to the largest
+        //concentration of the same signal
+        worst = 0;
+        for(i=0; i<num_signals; i++)
+        {
+            if(convolveFeedSignal(&ir, &signals[i], &out))
+            {
+                if(calculateFeedSignal(r, f, c, ir.inc, &signals[i], &direct))
+                {
+                    diff = 0;
+                    size = 0;
+                    for(ix=0; ix<out.num_points; ix++)
+                    {
+                        diff = fmax(diff, fabs(out.cr1[ix]-direct.cr1[ix]));
+                        diff = fmax(diff, fabs(out.cr2[ix]-direct.cr2[ix]));
+                        diff = fmax(diff, fabs(out.cr3[ix]-direct.cr3[ix]));
+                        size = fmax(size, fmax(fabs(direct.cr1[ix]), fmax(fabs(direct.cr2[ix]), fabs(direct.cr3[ix]))));
+                    }
+                    worst = fmax(worst, (size>0) ? diff/size : diff);
+                    freeSignalResponse(&direct);
+                }
+                freeSignalResponse(&out);
+            }
+        }
+        printf("Impulse response: %lf s  Convolution: %lf s  Direct stepping: %lf s\n",
+               response_time, convolve_time, step_time);
+        printf("Speedup of impulse response and convolution over direct stepping: %lf\n",
+               (response_time+convolve_time>0) ? step_time/(response_time+convolve_time) : 0);
+        printf("Largest relative difference: %.3e\n", worst);
+    }
+
+    fp = fopen(FEEDOUTFILE,"w");
+    if (fp == NULL)
+        printf("Sorry, could not open %s\n", FEEDOUTFILE);
+    for(i=0; i<num_signals; i++)
+    {
+        if(!convolveFeedSignal(&ir, &signals[i], &out))
+        {
+            printf("Sorry, not enough memory for signal %d\n", i+1);
+            continue;
+        }
+        printf("Signal %d: %d points, final C1: %lf C2: %lf C3: %lf\n", i+1, out.num_points,
+               out.cr1[out.num_points-1], out.cr2[out.num_points-1], out.cr3[out.num_points-1]);
+        if (fp != NULL)
+        {
+            fprintf(fp, "Signal %d\n", i+1);
+            fprintf(fp, "time C1 C2 C3\n");
+            for(ix=0; ix<out.num_points; ix++)
+                fprintf(fp, "%.17g %.17g %.17g %.17g\n", out.time_axis[ix], out.cr1[ix], out.cr2[ix], out.cr3[ix]);
+        }
+        freeSignalResponse(&out);
+    }
+    if (fp != NULL)
+    {
+        fclose(fp);
+        printf("The concentrations were saved to %s\n", FEEDOUTFILE);
+    }
+
+    calculateResidenceTime(&ir, FEED_C01, e01);
+    calculateResidenceTime(&ir, FEED_C03, e03);
+    printf("Residence time distribution at the outlet (reactor 3)\n");
+    printf("time E(t) from C01  E(t) from C03\n");
+    for(ix=0; ix<NUM_POINTS; ix++)
+        printf("%lf %lf %lf\n", ir.time_axis[ix], e01[ix], e03[ix]);
+    if((e01[NUM_POINTS-1]>0.01*getMaxDouble(e01, NUM_POINTS)) ||
+       (e03[NUM_POINTS-1]>0.01*getMaxDouble(e03, NUM_POINTS)))
+        printf("Warning: a pulse has not left the reactors by tf, E(t) is cut off\n");
+
+    freeImpulseResponse(&ir);
+    for(i=0; i<num_signals; i++)
+        freeFeedSignal(&signals[i]);
+}
+
+/*-----------------------------------------------------------------------
+Function: calculateFeedSignal
+Parameters:
+    REACTORS *r, FLOW_RATES *f
+    CONCENTRATIONS *c: supplies C10, C20, C30
+    inc: time step, the same as the impulse response uses
+    FEED_SIGNAL *s: feed concentrations over time
+    SIGNAL_RESPONSE *out: receives the concentrations, free them with
+                          freeSignalResponse
+Return:  TRUE if successful, FALSE if there was not enough memory
+Description:  Steps through the equations with the feed signal, the direct
+            way convolveFeedSignal is compared against with -benchmark.
+------------------------------------------------------------------------*/
+int calculateFeedSignal(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c, double inc,
+                        FEED_SIGNAL *s, SIGNAL_RESPONSE *out)
+{
+    double prev[NUM_REACTORS], next[NUM_REACTORS];
+    int n = s->num_points;
+    int ix;
+
+    out->num_points = n;
+    out->time_axis = malloc(n*sizeof(double));
+    out->cr1 = malloc(n*sizeof(double));
+    out->cr2 = malloc(n*sizeof(double));
+    out->cr3 = malloc(n*sizeof(double));
+    if((out->time_axis==NULL) || (out->cr1==NULL) || (out->cr2==NULL) || (out->cr3==NULL))
+    {
+        freeSignalResponse(out);
+        return(FALSE);
+    }
+
+    prev[0]=c->c1_0;
+    prev[1]=c->c2_0;
+    prev[2]=c->c3_0;
+    out->time_axis[0]=0;
+    for(ix=0; ix<n; ix++)
+    {
+        if(ix>0)
+            out->time_axis[ix]=out->time_axis[ix-1]+inc;
+        out->cr1[ix]=prev[0];
+        out->cr2[ix]=prev[1];
+        out->cr3[ix]=prev[2];
+        stepConcentrations(r, f, s->c_01[ix], s->c_03[ix], prev, next, inc);
+        memcpy(prev, next, sizeof(prev));
+    }
+    return(TRUE);
+}
+
+/*-----------------------------------------------------------------------
+Function: readFeedSignals
+Parameters:
+    filename: text file holding the feed signals
+    FEED_SIGNAL signals[]: receives the signals
+    max: number of elements in the array
+Return:  the number of signals read, 0 if the file could not be read
+Description:  Every signal starts with its number of points n, followed by
+            n lines holding C01 and C03 for one time step each:
+                3
+                10 20
+                12 20
+                10 0
+------------------------------------------------------------------------*/
+int readFeedSignals(char *filename, FEED_SIGNAL signals[], int max)
+{
+    FILE* fp;
+    int num_signals=0;
+    int n, ix;
+    int pass=TRUE;
+
+    fp = fopen(filename,"r");
+    if (fp == NULL)
+        return(0);
+
+    while((num_signals<max) && pass && (fscanf(fp, "%d", &n)==1))
+    {
+        if(n<=0)
+            break;
+        signals[num_signals].num_points = n;
+        signals[num_signals].c_01 = malloc(n*sizeof(double));
+        signals[num_signals].c_03 = malloc(n*sizeof(double));
+        if((signals[num_signals].c_01==NULL) || (signals[num_signals].c_03==NULL))
+            pass = FALSE;
+        for(ix=0; (ix<n) && pass; ix++)
+        {
+            if(fscanf(fp, "%lf %lf", &signals[num_signals].c_01[ix], &signals[num_signals].c_03[ix])!=2)
+                pass = FALSE;
+        }
+        if(pass)
+            num_signals++;
+        else
+        {
+            printf("Sorry, signal %d in %s is not complete\n", num_signals+1, filename);
+            freeFeedSignal(&signals[num_signals]);
+        }
+    }
+    fclose(fp);
+    return(num_signals);
+}
+
+/*-----------------------------------------------------------------------
+Function: calculateImpulseResponse
+Parameters:
+    REACTORS *r, FLOW_RATES *f
+    CONCENTRATIONS *c: supplies C10, C20, C30 and the final time
+    num_points: length of the longest feed signal that will be convolved
+    IMPULSE_RESPONSE *ir: receives the responses
+Return:  TRUE if successful, FALSE if there was not enough memory
+Description:  The reactors are linear and do not change over time, so the
+            response to any feed signal is the response to the initial
+            concentrations plus the feed signal convolved with the response
+            to a single unit pulse of each feed. This computes those
+            responses once, along with their spectra for convolveFeedSignal.
+            A pulse is not assumed to die out (with the Q33 term as it is in
+            stepConcentrations it never does), so the pulse responses are as
+            long as the longest signal. Free the result with freeImpulseResponse.
+------------------------------------------------------------------------*/
+int calculateImpulseResponse(REACTORS *r, FLOW_RATES *f, CONCENTRATIONS *c,
+                             int num_points, IMPULSE_RESPONSE *ir)
+{
+    double prev[NUM_REACTORS], next[NUM_REACTORS];
+    double pulse[NUM_FEEDS];
+    int pass=TRUE;
+    int feed, rx, ix;
+
+    //E(t) is read from the first NUM_POINTS values of the pulse responses
+    if(num_points<NUM_POINTS)
+        num_points = NUM_POINTS;
+    ir->num_points = num_points;
+    for(ir->fft_size=1; ir->fft_size<2*num_points-1; ir->fft_size*=2);
+    ir->inc = (c->time_final)/(NUM_POINTS-1);
+    ir->time_axis[0]=0;
+    for(ix=1; ix<NUM_POINTS; ix++)
+        ir->time_axis[ix]=ir->time_axis[ix-1]+ir->inc;
+
+    for(rx=0; rx<NUM_REACTORS; rx++)
+    {
+        ir->initial[rx] = malloc(num_points*sizeof(double));
+        if(ir->initial[rx]==NULL)
+            pass = FALSE;
+        for(feed=0; feed<NUM_FEEDS; feed++)
+        {
+            ir->h[feed][rx] = malloc(num_points*sizeof(double));
+            ir->h_re[feed][rx] = malloc(ir->fft_size*sizeof(double));
+            ir->h_im[feed][rx] = malloc(ir->fft_size*sizeof(double));
+            if((ir->h[feed][rx]==NULL) || (ir->h_re[feed][rx]==NULL) || (ir->h_im[feed][rx]==NULL))
+                pass = FALSE;
+        }
+    }
+    if(!pass)
+    {
+        freeImpulseResponse(ir);
+        return(FALSE);
+    }
+
+    //response to the initial concentrations with both feeds off
+    prev[0]=c->c1_0;
+    prev[1]=c->c2_0;
+    prev[2]=c->c3_0;
+    for(ix=0; ix<num_points; ix++)
+    {
+        for(rx=0; rx<NUM_REACTORS; rx++)
+            ir->initial[rx][ix]=prev[rx];
+        stepConcentrations(r, f, 0, 0, prev, next, ir->inc);
+        memcpy(prev, next, sizeof(prev));
+    }
+
+    //response to a unit feed during the first step only, starting empty
+    for(feed=0; feed<NUM_FEEDS; feed++)
+    {
+        for(rx=0; rx<NUM_REACTORS; rx++)
+            prev[rx]=0;
+        for(ix=0; ix<num_points; ix++)
+        {
+            for(rx=0; rx<NUM_REACTORS; rx++)
+                ir->h[feed][rx][ix]=prev[rx];
+            pulse[FEED_C01]=0;
+            pulse[FEED_C03]=0;
+            if(ix==0)
+                pulse[feed]=1;
+            stepConcentrations(r, f, pulse[FEED_C01], pulse[FEED_C03], prev, next, ir->inc);
+            memcpy(prev, next, sizeof(prev));
+        }
+
+        for(rx=0; rx<NUM_REACTORS; rx++)
+        {
+            for(ix=0; ix<ir->fft_size; ix++)
+            {
+                ir->h_re[feed][rx][ix]=(ix<num_points) ? ir->h[feed][rx][ix] : 0;
+                ir->h_im[feed][rx][ix]=0;
+            }
+            fft(ir->h_re[feed][rx], ir->h_im[feed][rx], ir->fft_size, FALSE);
+        }
+    }
+    return(TRUE);
+}
+
+/*-----------------------------------------------------------------------
+Function: convolveFeedSignal
+Parameters:
+    IMPULSE_RESPONSE *ir: computed by calculateImpulseResponse
+    FEED_SIGNAL *s: feed concentrations over time
+    SIGNAL_RESPONSE *out: receives the concentrations, free them with
+                          freeSignalResponse
+Return:  TRUE if successful, FALSE if the signal is longer than the
+         impulse response was computed for or there was not enough memory
+Description:  Gets the concentrations for a feed signal without stepping
+            through the equations again. The spectrum of each feed signal
+            is multiplied with the stored spectra (FFT convolution), one
+            inverse transform per reactor gives the concentrations, and the
+            response to the initial concentrations is added on top.
+            A signal much shorter than the longest one uses its own smaller
+            transform of the pulse responses cut to its length. The FFT
+            error is about 1e-16 of the largest value transformed, and the
+            pulse responses keep growing, so the stored spectra would bury
+            a short signal in the error of a long one.
+------------------------------------------------------------------------*/
+int convolveFeedSignal(IMPULSE_RESPONSE *ir, FEED_SIGNAL *s, SIGNAL_RESPONSE *out)
+{
+    double *u_re, *u_im, *k_re=NULL, *k_im=NULL;
+    double *y_re[NUM_REACTORS], *y_im[NUM_REACTORS];
+    double *h_re, *h_im;
+    double *signal;
+    double *cr[NUM_REACTORS];
+    int n = s->num_points;
+    int size;
+    int pass=TRUE;
+    int feed, rx, ix;
+
+    if(n>ir->num_points)
+        return(FALSE);
+    for(size=1; size<2*n-1; size*=2);
+    if(size>ir->fft_size)
+        size = ir->fft_size;
+    out->num_points = n;
+    out->time_axis = malloc(n*sizeof(double));
+    out->cr1 = malloc(n*sizeof(double));
+    out->cr2 = malloc(n*sizeof(double));
+    out->cr3 = malloc(n*sizeof(double));
+    u_re = malloc(size*sizeof(double));
+    u_im = malloc(size*sizeof(double));
+    if((out->time_axis==NULL) || (out->cr1==NULL) || (out->cr2==NULL) || (out->cr3==NULL) ||
+       (u_re==NULL) || (u_im==NULL))
+        pass = FALSE;
+    if(size<ir->fft_size)
+    {
+        k_re = malloc(size*sizeof(double));
+        k_im = malloc(size*sizeof(double));
+        if((k_re==NULL) || (k_im==NULL))
+            pass = FALSE;
+    }
+    for(rx=0; rx<NUM_REACTORS; rx++)
+    {
+        y_re[rx] = calloc(size, sizeof(double));
+        y_im[rx] = calloc(size, sizeof(double));
+        if((y_re[rx]==NULL) || (y_im[rx]==NULL))
+            pass = FALSE;
+    }
+
+    if(pass)
+    {
+        for(feed=0; feed<NUM_FEEDS; feed++)
+        {
+            signal = (feed==FEED_C01) ? s->c_01 : s->c_03;
+            for(ix=0; ix<size; ix++)
+            {
+                u_re[ix]=(ix<n) ? signal[ix] : 0;
+                u_im[ix]=0;
+            }
+            fft(u_re, u_im, size, FALSE);
+            for(rx=0; rx<NUM_REACTORS; rx++)
+            {
+                h_re = ir->h_re[feed][rx];
+                h_im = ir->h_im[feed][rx];
+                if(size<ir->fft_size)
+                {
+                    for(ix=0; ix<size; ix++)
+                    {
+                        k_re[ix]=(ix<n) ? ir->h[feed][rx][ix] : 0;
+                        k_im[ix]=0;
+                    }
+                    fft(k_re, k_im, size, FALSE);
+                    h_re = k_re;
+                    h_im = k_im;
+                }
+                for(ix=0; ix<size; ix++)
+                {
+                    y_re[rx][ix]+=h_re[ix]*u_re[ix]-h_im[ix]*u_im[ix];
+                    y_im[rx][ix]+=h_re[ix]*u_im[ix]+h_im[ix]*u_re[ix];
+                }
+            }
+        }
+
+        cr[0]=out->cr1;
+        cr[1]=out->cr2;
+        cr[2]=out->cr3;
+        for(rx=0; rx<NUM_REACTORS; rx++)
+        {
+            fft(y_re[rx], y_im[rx], size, TRUE);
+            for(ix=0; ix<n; ix++)
+                cr[rx][ix]=ir->initial[rx][ix]+y_re[rx][ix];
+        }
+        out->time_axis[0]=0;
+        for(ix=1; ix<n; ix++)
+            out->time_axis[ix]=out->time_axis[ix-1]+ir->inc;
+    }
+    else
+        freeSignalResponse(out);
+
+    free(u_re);
+    free(u_im);
+    free(k_re);
+    free(k_im);
+    for(rx=0; rx<NUM_REACTORS; rx++)
+    {
+        free(y_re[rx]);
+        free(y_im[rx]);
+    }
+    return(pass);
+}
+
+/*-------------------------------------------------
+ Function: freeImpulseResponse
+ Parameters:
+    IMPULSE_RESPONSE *ir
+ Return value: none.
+ Description: Frees the memory taken by calculateImpulseResponse.
+-------------------------------------------------*/
+void freeImpulseResponse(IMPULSE_RESPONSE *ir)
+{
+    int feed, rx;
+
+    for(rx=0; rx<NUM_REACTORS; rx++)
+    {
+        free(ir->initial[rx]);
+        ir->initial[rx] = NULL;
+        for(feed=0; feed<NUM_FEEDS; feed++)
+        {
+            free(ir->h[feed][rx]);
+            free(ir->h_re[feed][rx]);
+            free(ir->h_im[feed][rx]);
+            ir->h[feed][rx] = NULL;
+            ir->h_re[feed][rx] = NULL;
+            ir->h_im[feed][rx] = NULL;
+        }
+    }
+}
+
+/*-------------------------------------------------
+ Function: freeFeedSignal
+ Parameters:
+    FEED_SIGNAL *s
+ Return value: none.
+ Description: Frees the memory taken by readFeedSignals.
+-------------------------------------------------*/
+void freeFeedSignal(FEED_SIGNAL *s)
+{
+    free(s->c_01);
+    free(s->c_03);
+    s->c_01 = NULL;
+    s->c_03 = NULL;
+}
+
+/*-------------------------------------------------
+ Function: freeSignalResponse
+ Parameters:
+    SIGNAL_RESPONSE *out
+ Return value: none.
+ Description: Frees the memory taken by convolveFeedSignal.
+-------------------------------------------------*/
+void freeSignalResponse(SIGNAL_RESPONSE *out)
+{
+    free(out->time_axis);
+    free(out->cr1);
+    free(out->cr2);
+    free(out->cr3);
+    out->time_axis = NULL;
+    out->cr1 = NULL;
+    out->cr2 = NULL;
+    out->cr3 = NULL;
+}
+
+/*-----------------------------------------------------------------------
+Function: calculateResidenceTime
+Parameters:
+    IMPULSE_RESPONSE *ir: computed by calculateImpulseResponse
+    feed: FEED_C01 or FEED_C03
+    e: receives the residence time distribution E(t), NUM_POINTS values
+Return:  void
+Description:  The residence time distribution is the outlet (reactor 3)
+            response to a pulse in the feed, scaled so that its area over
+            the computed time is 1.
+------------------------------------------------------------------------*/
+void calculateResidenceTime(IMPULSE_RESPONSE *ir, int feed, double e[])
+{
+    double inc, area=0;
+    int ix;
+
+    inc = ir->time_axis[1]-ir->time_axis[0];
+    for(ix=0; ix<NUM_POINTS; ix++)
+        area+=ir->h[feed][NUM_REACTORS-1][ix]*inc;
+    for(ix=0; ix<NUM_POINTS; ix++)
+    {
+        if(area!=0)
+            e[ix]=ir->h[feed][NUM_REACTORS-1][ix]/area;
+        else
+            e[ix]=0;
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: fft
+Parameters:
+    re, im: real and imaginary parts, replaced by the transform
+    n: number of values, must be a power of two
+    inverse: TRUE for the inverse transform (includes the 1/n scaling)
+Return:  void
+Description:  Radix-2 fast Fourier transform done in place.
+------------------------------------------------------------------------*/
+void fft(double re[], double im[], int n, int inverse)
+{
+    double angle, w_re, w_im, step_re, step_im, t_re, t_im, temp;
+    int i, j, k, len;
+
+    //put the values in bit reversed order
+    for(i=1, j=0; i<n; i++)
+    {
+        for(k=n>>1; j&k; k>>=1)
+            j^=k;
+        j^=k;
+        if(i<j)
+        {
+            temp=re[i]; re[i]=re[j]; re[j]=temp;
+            temp=im[i]; im[i]=im[j]; im[j]=temp;
+        }
+    }
+
+    for(len=2; len<=n; len<<=1)
+    {
+        angle = (inverse ? 2 : -2)*PI/len;
+        step_re = cos(angle);
+        step_im = sin(angle);
+        for(i=0; i<n; i+=len)
+        {
+            w_re=1;
+            w_im=0;
+            for(k=0; k<len/2; k++)
+            {
+                t_re=re[i+k+len/2]*w_re-im[i+k+len/2]*w_im;
+                t_im=re[i+k+len/2]*w_im+im[i+k+len/2]*w_re;
+                re[i+k+len/2]=re[i+k]-t_re;
+                im[i+k+len/2]=im[i+k]-t_im;
+                re[i+k]+=t_re;
+                im[i+k]+=t_im;
+                temp=w_re*step_re-w_im*step_im;
+                w_im=w_re*step_im+w_im*step_re;
+                w_re=temp;
+            }
+        }
+    }
+
+    if(inverse)
+    {
+        for(i=0; i<n; i++)
+        {
+            re[i]/=n;
+            im[i]/=n;
+        }
     }
 }
 
@@ -451,6 +1615,500 @@ int retrieveFiles(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr)
     return record_choice;
 }
 
+/*-----------------------------------------------------------------------
+Function: storeTrajectory
+Parameters:
+    REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr
+    steps_per_point: time steps taken between two plotted points
+    parareal: TRUE when the concentrations were computed with Parareal
+Return:  void
+Description:  Appends the inputs and the computed concentrations to the
+            trajectory file as one compressed block, and its position to
+            the index file. When the time axis is uniform every
+            delta-of-delta is zero, so only the first time and the increment
+            are kept. Every other series is encoded both ways
+            (encodeSeriesXor and encodeSeriesDod) and the smaller is kept.
+------------------------------------------------------------------------*/
+void storeTrajectory(REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr,
+                     int steps_per_point, int parareal)
+{
+    FILE* fp;
+    TRAJECTORY_HEADER header;
+    BIT_STREAM series[NUM_SERIES];
+    BIT_STREAM other;
+    double *values[NUM_SERIES];
+    double time_value;
+    long offset;
+    int uniform_time;
+    int pass=TRUE;
+    int ix;
+
+    values[0] = cPtr->time_axis;
+    values[1] = cPtr->cr1;
+    values[2] = cPtr->cr2;
+    values[3] = cPtr->cr3;
+
+    memset(&header, 0, sizeof(TRAJECTORY_HEADER));
+    header.magic = TRAJ_MAGIC;
+    header.num_points = NUM_POINTS;
+    header.inputs.v1 = rPtr->v_1;
+    header.inputs.v2 = rPtr->v_2;
+    header.inputs.v3 = rPtr->v_3;
+    header.inputs.q01 = fPtr->Q_01;
+    header.inputs.q03 = fPtr->Q_03;
+    header.inputs.q12 = fPtr->Q_12;
+    header.inputs.q23 = fPtr->Q_23;
+    header.inputs.q31 = fPtr->Q_31;
+    header.inputs.q33 = fPtr->Q_33;
+    header.inputs.c01 = cPtr->c_01;
+    header.inputs.c03 = cPtr->c_03;
+    header.inputs.c10 = cPtr->c1_0;
+    header.inputs.c20 = cPtr->c2_0;
+    header.inputs.c30 = cPtr->c3_0;
+    header.inputs.time_final = cPtr->time_final;
+    header.steps_per_point = steps_per_point;
+    header.parareal = parareal;
+    header.time_start = cPtr->time_axis[0];
+    header.time_inc = cPtr->time_axis[1]-cPtr->time_axis[0];
+
+    //the time axis is uniform if adding the same increment rebuilds it exactly
+    uniform_time = TRUE;
+    time_value = header.time_start;
+    for(ix=1; ix<NUM_POINTS; ix++)
+    {
+        time_value = time_value+header.time_inc;
+        if(memcmp(&time_value, &cPtr->time_axis[ix], sizeof(double))!=0)
+            uniform_time = FALSE;
+    }
+
+    for(ix=0; ix<NUM_SERIES; ix++)
+    {
+        if((ix==0) && uniform_time)
+        {
+            header.series_codec[ix] = CODEC_UNIFORM;
+            series[ix].num_bits = 0;
+        }
+        else
+        {
+            encodeSeriesXor(values[ix], NUM_POINTS, &series[ix]);
+            header.series_codec[ix] = CODEC_XOR;
+            encodeSeriesDod(values[ix], NUM_POINTS, &other);
+            if(other.num_bits<series[ix].num_bits)
+            {
+                series[ix] = other;
+                header.series_codec[ix] = CODEC_DOD;
+            }
+        }
+        header.series_bytes[ix] = (series[ix].num_bits+7)/8;
+    }
+
+    fp = fopen(TRAJFILE,"ab");
+    if (fp == NULL)
+    {
+        printf("Sorry, could not open %s\n", TRAJFILE);
+        return;
+    }
+    fseek(fp, 0, SEEK_END);
+    offset = ftell(fp);
+    if((offset<0) || (fwrite(&header, sizeof(TRAJECTORY_HEADER),1,fp)!=1))
+        pass = FALSE;
+    for(ix=0; (ix<NUM_SERIES) && pass; ix++)
+    {
+        if(fwrite(series[ix].bytes, 1, header.series_bytes[ix], fp)!=(size_t)header.series_bytes[ix])
+            pass = FALSE;
+    }
+    if(fclose(fp)!=0)
+        pass = FALSE;
+
+    //the block is only listed in the index once it is completely written
+    if(pass)
+    {
+        fp = fopen(TRAJINDEX,"ab");
+        if((fp == NULL) || (fwrite(&offset, sizeof(long),1,fp)!=1))
+            pass = FALSE;
+        if((fp != NULL) && (fclose(fp)!=0))
+            pass = FALSE;
+    }
+    if(!pass)
+        printf("Sorry, the trajectory could not be archived in %s\n", TRAJFILE);
+}
+
+/*-----------------------------------------------------------------------
+Function: retrieveTrajectory
+Parameters:
+    int record: zero based position of the trajectory in the file
+    REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr
+Return:  TRUE if the trajectory was found and decoded, FALSE otherwise
+Description:  Looks up the position of the block in the index file and
+            reads only that block. The structures are only changed when
+            the whole block was read and decoded.
+------------------------------------------------------------------------*/
+int retrieveTrajectory(int record, REACTORS *rPtr, FLOW_RATES *fPtr, CONCENTRATIONS *cPtr)
+{
+    FILE* fp;
+    TRAJECTORY_HEADER header;
+    BIT_STREAM series;
+    CONCENTRATIONS loaded;
+    double *values[NUM_SERIES];
+    long offset;
+    int found=FALSE;
+    int i, ix;
+
+    if(record<0)
+        return(FALSE);
+
+    fp = fopen(TRAJINDEX,"rb");
+    if (fp == NULL)
+        return(FALSE);
+    if((fseek(fp, (long)record*sizeof(long), SEEK_SET)==0) &&
+       (fread(&offset, sizeof(long),1,fp)==1))
+        found = TRUE;
+    fclose(fp);
+    if(!found)
+        return(FALSE);
+
+    fp = fopen(TRAJFILE,"rb");
+    if (fp == NULL)
+        return(FALSE);
+    if((fseek(fp, offset, SEEK_SET)!=0) ||
+       (fread(&header, sizeof(TRAJECTORY_HEADER),1,fp)!=1) ||
+       (header.magic!=TRAJ_MAGIC) || (header.num_points!=NUM_POINTS))
+        found = FALSE;
+
+    values[0] = loaded.time_axis;
+    values[1] = loaded.cr1;
+    values[2] = loaded.cr2;
+    values[3] = loaded.cr3;
+    for(ix=0; (ix<NUM_SERIES) && found; ix++)
+    {
+        memset(series.bytes, 0, MAX_SERIES_BYTES);
+        if((header.series_bytes[ix]<0) || (header.series_bytes[ix]>MAX_SERIES_BYTES))
+            found = FALSE;
+        else if(fread(series.bytes, 1, header.series_bytes[ix], fp)!=(size_t)header.series_bytes[ix])
+            found = FALSE;
+        else if((header.series_codec[ix]==CODEC_UNIFORM) && (ix==0) && (header.series_bytes[ix]==0))
+        {
+            loaded.time_axis[0] = header.time_start;
+            for(i=1; i<NUM_POINTS; i++)
+                loaded.time_axis[i] = loaded.time_axis[i-1]+header.time_inc;
+        }
+        else if(header.series_codec[ix]==CODEC_XOR)
+            found = decodeSeriesXor(&series, header.series_bytes[ix], values[ix], NUM_POINTS);
+        else if(header.series_codec[ix]==CODEC_DOD)
+            found = decodeSeriesDod(&series, header.series_bytes[ix], values[ix], NUM_POINTS);
+        else
+            found = FALSE;
+    }
+    fclose(fp);
+
+    if(found)
+    {
+        rPtr->v_1 = header.inputs.v1;
+        rPtr->v_2 = header.inputs.v2;
+        rPtr->v_3 = header.inputs.v3;
+        fPtr->Q_01 = header.inputs.q01;
+        fPtr->Q_03 = header.inputs.q03;
+        fPtr->Q_12 = header.inputs.q12;
+        fPtr->Q_23 = header.inputs.q23;
+        fPtr->Q_31 = header.inputs.q31;
+        fPtr->Q_33 = header.inputs.q33;
+        loaded.c_01 = header.inputs.c01;
+        loaded.c_03 = header.inputs.c03;
+        loaded.c1_0 = header.inputs.c10;
+        loaded.c2_0 = header.inputs.c20;
+        loaded.c3_0 = header.inputs.c30;
+        loaded.time_final = header.inputs.time_final;
+        *cPtr = loaded;
+    }
+    return(found);
+}
+
+/*-----------------------------------------------------------------------
+Function: readOptions
+Parameters:
+    argc, argv: the command line given to main
+    OPTIONS *oPtr: receives the options
+Return:  TRUE if the command line was understood, FALSE otherwise
+Description:  Reads the command line options:
+              -archive   append the computed concentrations to TRAJFILE
+              -load N    plot archived trajectory N instead of asking for inputs
+            -feeds F   evaluate every feed signal in file F by impulse response
+            -parareal N  parallel-in-time integration with N steps per plotted point
+            -slices P    with -parareal, use P time slices instead of one per thread
+            -benchmark   with -parareal or -feeds, also time direct stepping
+            Without options the program asks the same questions as before.
+------------------------------------------------------------------------*/
+int readOptions(int argc, char *argv[], OPTIONS *oPtr)
+{
+    int i;
+
+    oPtr->archive = FALSE;
+    oPtr->load_record = 0;
+    oPtr->feeds_file = NULL;
+    oPtr->parareal_steps = 0;
+    oPtr->parareal_slices = 0;
+    oPtr->benchmark = FALSE;
+    for(i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i], "-archive")==0)
+            oPtr->archive = TRUE;
+        else if((strcmp(argv[i], "-load")==0) && (i+1<argc) && (atoi(argv[i+1])>0))
+        {
+            oPtr->load_record = atoi(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-feeds")==0) && (i+1<argc))
+        {
+            oPtr->feeds_file = argv[i+1];
+            i++;
+        }
+        else if((strcmp(argv[i], "-parareal")==0) && (i+1<argc) && (atoi(argv[i+1])>0))
+        {
+            oPtr->parareal_steps = atoi(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-slices")==0) && (i+1<argc) && (atoi(argv[i+1])>0))
+        {
+            oPtr->parareal_slices = atoi(argv[i+1]);
+            i++;
+        }
+        else if(strcmp(argv[i], "-benchmark")==0)
+            oPtr->benchmark = TRUE;
+        else
+        {
+            printf("Sorry, %s is not a valid option\n", argv[i]);
+            printf("Options: -archive, -load N, -feeds file, -parareal N, -slices P, -benchmark\n");
+            return(FALSE);
+        }
+    }
+    return(TRUE);
+}
+
+/*-----------------------------------------------------------------------
+Function: encodeSeriesXor
+Parameters:
+    arr: reference to array of double values
+    n: number of elements in the array
+    BIT_STREAM *b: receives the compressed bits
+Return:  void
+Description:  The first value is written as is. Each following value is
+            XORed with the one before it (Gorilla encoding):
+              '0'                  the value did not change
+              '10' + bits          changed bits fit in the previous window
+              '11' + 5 bits leading zeros + 6 bits length + bits
+            Best when values repeat, e.g. once a reactor has settled.
+------------------------------------------------------------------------*/
+void encodeSeriesXor(double arr[], int n, BIT_STREAM *b)
+{
+    unsigned long long prev, cur, x;
+    int lead, trail, sig;
+    int prev_lead=-1, prev_trail=0;
+    int ix;
+
+    memset(b->bytes, 0, MAX_SERIES_BYTES);
+    b->num_bits = 0;
+    memcpy(&prev, &arr[0], sizeof(double));
+    putBits(b, prev, 64);
+    for(ix=1; ix<n; ix++)
+    {
+        memcpy(&cur, &arr[ix], sizeof(double));
+        x = cur^prev;
+        if(x==0)
+            putBits(b, 0, 1);
+        else
+        {
+            putBits(b, 1, 1);
+            for(lead=0; ((x>>(63-lead))&1)==0; lead++);
+            for(trail=0; ((x>>trail)&1)==0; trail++);
+            if(lead>31)
+                lead = 31;  //only 5 bits are available to store it
+            if((prev_lead>=0) && (lead>=prev_lead) && (trail>=prev_trail))
+            {
+                putBits(b, 0, 1);
+                putBits(b, x>>prev_trail, 64-prev_lead-prev_trail);
+            }
+            else
+            {
+                sig = 64-lead-trail;
+                putBits(b, 1, 1);
+                putBits(b, lead, 5);
+                putBits(b, sig-1, 6);   //sig is 1 to 64, stored as 0 to 63
+                putBits(b, x>>trail, sig);
+                prev_lead = lead;
+                prev_trail = trail;
+            }
+        }
+        prev = cur;
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: decodeSeriesXor
+Parameters:
+    BIT_STREAM *b: compressed bits written by encodeSeriesXor
+    num_bytes: number of bytes of compressed bits in b
+    arr: reference to array receiving the double values
+    n: number of elements in the array
+Return:  TRUE if exactly num_bytes were decoded, FALSE otherwise
+Description:  Reverses encodeSeriesXor.
+------------------------------------------------------------------------*/
+int decodeSeriesXor(BIT_STREAM *b, int num_bytes, double arr[], int n)
+{
+    unsigned long long prev, x;
+    int lead=0, trail=0, sig;
+    int pos=0;
+    int ix;
+
+    b->num_bits = num_bytes*8;
+    prev = getBits(b, &pos, 64);
+    memcpy(&arr[0], &prev, sizeof(double));
+    for(ix=1; (ix<n) && (pos<=b->num_bits); ix++)
+    {
+        if(getBits(b, &pos, 1)==1)
+        {
+            if(getBits(b, &pos, 1)==1)
+            {
+                lead = (int)getBits(b, &pos, 5);
+                sig = (int)getBits(b, &pos, 6)+1;
+                trail = 64-lead-sig;
+                if(trail<0)
+                    return(FALSE);
+            }
+            x = getBits(b, &pos, 64-lead-trail)<<trail;
+            prev = prev^x;
+        }
+        memcpy(&arr[ix], &prev, sizeof(double));
+    }
+    return((pos<=b->num_bits) && ((pos+7)/8==num_bytes));
+}
+
+/*-----------------------------------------------------------------------
+Function: encodeSeriesDod
+Parameters:
+    arr: reference to array of double values
+    n: number of elements in the array
+    BIT_STREAM *b: receives the compressed bits
+Return:  void
+Description:  Delta-of-delta encoding done on the bits of the doubles read
+            as 64 bit integers. The first value is written as is, then for
+            every value the change in the difference to the value before it:
+              '0'                             the difference did not change
+              '1' + 6 bits length + bits      zigzag of the change in difference
+            Best on smoothly changing values.
+------------------------------------------------------------------------*/
+void encodeSeriesDod(double arr[], int n, BIT_STREAM *b)
+{
+    unsigned long long prev, cur, delta, prev_delta=0, dod, zigzag;
+    int len;
+    int ix;
+
+    memset(b->bytes, 0, MAX_SERIES_BYTES);
+    b->num_bits = 0;
+    memcpy(&prev, &arr[0], sizeof(double));
+    putBits(b, prev, 64);
+    for(ix=1; ix<n; ix++)
+    {
+        memcpy(&cur, &arr[ix], sizeof(double));
+        delta = cur-prev;
+        dod = delta-prev_delta;
+        //zigzag puts the sign in the lowest bit so small changes have few bits
+        zigzag = (dod<<1)^(0-(dod>>63));
+        if(zigzag==0)
+            putBits(b, 0, 1);
+        else
+        {
+            for(len=64; ((zigzag>>(len-1))&1)==0; len--);
+            putBits(b, 1, 1);
+            putBits(b, len-1, 6);   //len is 1 to 64, stored as 0 to 63
+            putBits(b, zigzag, len);
+        }
+        prev_delta = delta;
+        prev = cur;
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: decodeSeriesDod
+Parameters:
+    BIT_STREAM *b: compressed bits written by encodeSeriesDod
+    num_bytes: number of bytes of compressed bits in b
+    arr: reference to array receiving the double values
+    n: number of elements in the array
+Return:  TRUE if exactly num_bytes were decoded, FALSE otherwise
+Description:  Reverses encodeSeriesDod.
+------------------------------------------------------------------------*/
+int decodeSeriesDod(BIT_STREAM *b, int num_bytes, double arr[], int n)
+{
+    unsigned long long prev, delta=0, zigzag;
+    int pos=0;
+    int ix;
+
+    b->num_bits = num_bytes*8;
+    prev = getBits(b, &pos, 64);
+    memcpy(&arr[0], &prev, sizeof(double));
+    for(ix=1; (ix<n) && (pos<=b->num_bits); ix++)
+    {
+        if(getBits(b, &pos, 1)==1)
+        {
+            zigzag = getBits(b, &pos, (int)getBits(b, &pos, 6)+1);
+            delta = delta+((zigzag>>1)^(0-(zigzag&1)));
+        }
+        prev = prev+delta;
+        memcpy(&arr[ix], &prev, sizeof(double));
+    }
+    return((pos<=b->num_bits) && ((pos+7)/8==num_bytes));
+}
+
+/*-----------------------------------------------------------------------
+Function: putBits
+Parameters:
+    BIT_STREAM *b
+    value: bits to write, right aligned
+    n: number of bits to write (0 to 64)
+Return:  void
+Description:  Appends the n low bits of value to the stream, most
+            significant bit first.
+------------------------------------------------------------------------*/
+void putBits(BIT_STREAM *b, unsigned long long value, int n)
+{
+    int i;
+
+    for(i=n-1; i>=0; i--)
+    {
+        if((value>>i)&1)
+            b->bytes[b->num_bits/8] |= (unsigned char)(0x80>>(b->num_bits%8));
+        b->num_bits++;
+    }
+}
+
+/*-----------------------------------------------------------------------
+Function: getBits
+Parameters:
+    BIT_STREAM *b
+    pos: reference to the current bit position, advanced by n
+    n: number of bits to read (0 to 64)
+Return:  the bits read, right aligned
+Description:  Reads n bits written by putBits. Reading past b->num_bits
+            returns 0 and moves pos past the end, so the caller can tell.
+------------------------------------------------------------------------*/
+unsigned long long getBits(BIT_STREAM *b, int *pos, int n)
+{
+    unsigned long long value=0;
+    int i;
+
+    if(*pos+n>b->num_bits)
+    {
+        *pos = b->num_bits+1;
+        return(0);
+    }
+    for(i=0; i<n; i++)
+    {
+        value = (value<<1)|((b->bytes[*pos/8]>>(7-*pos%8))&1);
+        (*pos)++;
+    }
+    return(value);
+}
+
 /*-------------------------------------------------
  Function: getMinDouble
  Parameters: